@@ -0,0 +1,229 @@
+#include <string.h>
+#include <time.h> // For clock_gettime()
+#include "markov_index.h"
+
+#define ARGS_NUM 2
+#define SEED_INDEX 1
+#define VOCABULARY_INDEX 2
+#define BASE 10
+
+#define ARGS_NUM_ERROR_MESSAGE "Usage: the number of arguments should be 2.\n"
+
+#define MAX_WORD 16
+#define EDGES_PER_WORD 8
+#define QUERIES_NUM 1000000
+#define SCAN_QUERIES_NUM 100
+#define BEAM_QUERIES_NUM 100000
+#define TOP_K 5
+#define BEAM_STEPS 4
+#define BEAM_WIDTH 4
+
+static bool end_of_sentence (void *data)
+{
+  char *string_data = (char *) data;
+  return !strcmp (&string_data[strlen (string_data) - 1], ".");
+}
+
+static int comp_data (void *first, void *second)
+{
+  return strcmp ((char *) first, (char *) second);
+}
+
+static void *cpy_func (void *data)
+{
+  char *string_data = (char *) data;
+  char *new_data = calloc (1, strlen (string_data) + 1);
+  if (new_data)
+  {
+    strcpy (new_data, string_data);
+  }
+  return (void *) new_data;
+}
+
+static void free_data_func (void *data)
+{
+  free (data);
+}
+
+/**
+ * FNV-1a hash of a string.
+ */
+static unsigned long hash_data (void *data)
+{
+  unsigned long hash = 14695981039346656037UL;
+  for (unsigned char *c = data; *c; c++)
+  {
+    hash = (hash ^ *c) * 1099511628211UL;
+  }
+  return hash;
+}
+
+static double seconds_since (const struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return (double) (now.tv_sec - start->tv_sec)
+         + (double) (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Get a word number skewed towards small numbers, like word frequencies.
+ */
+static int skewed_word (int words_num)
+{
+  double uniform = (double) rand () / ((double) RAND_MAX + 1);
+  return (int) (uniform * uniform * uniform * words_num);
+}
+
+/**
+ * Fill markov_chain with words_num words "w<number>", each followed by
+ * EDGES_PER_WORD skewed random words. Every tenth word ends a sentence.
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int fill_database (MarkovChain *markov_chain, int words_num,
+                          MarkovNode **nodes)
+{
+  char word[MAX_WORD];
+  for (int i = 0; i < words_num; i++)
+  {
+    snprintf (word, MAX_WORD, (i % 10 == 9) ? "w%d." : "w%d", i);
+    // every word is new, no need to look it up first
+    Node *node = new_node (markov_chain, word);
+    if (!node)
+    {
+      return EXIT_FAILURE;
+    }
+    nodes[i] = node->data;
+  }
+  for (int i = 0; i < words_num; i++)
+  {
+    for (int j = 0; j < EDGES_PER_WORD && !end_of_sentence (nodes[i]->data);
+         j++)
+    {
+      if (!add_node_to_frequencies_list (nodes[i],
+                                         nodes[skewed_word (words_num)],
+                                         markov_chain))
+      {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Answer a top-k query the way it is done without the index: find the word in
+ * the database, copy its frequencies and sort them.
+ */
+static int scan_top_k (MarkovChain *markov_chain, void *data_ptr,
+                       MarkovNodeFrequency *sorted)
+{
+  MarkovNode *markov_node = get_node_from_database (markov_chain,
+                                                    data_ptr)->data;
+  if (markov_node->follow_num)
+  {
+    memcpy (sorted, markov_node->frequencies_list,
+            markov_node->follow_num * sizeof (MarkovNodeFrequency));
+  }
+  for (int i = 1; i < markov_node->follow_num; i++)
+  {
+    MarkovNodeFrequency curr_f = sorted[i];
+    int j = i;
+    for (; j > 0 && sorted[j - 1].frequency < curr_f.frequency; j--)
+    {
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = curr_f;
+  }
+  return (markov_node->follow_num < TOP_K) ? markov_node->follow_num : TOP_K;
+}
+
+static void run_benchmark (MarkovChain *markov_chain, MarkovNode **nodes,
+                           int words_num, const int *queries)
+{
+  struct timespec start;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  MarkovIndex *index = build_markov_index (markov_chain, hash_data);
+  if (!index)
+  {
+    return;
+  }
+  printf ("Index of %d words built in %.3fs\n", words_num,
+          seconds_since (&start));
+
+  MarkovNodeFrequency sorted[EDGES_PER_WORD];
+  long found = 0;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < SCAN_QUERIES_NUM; i++)
+  {
+    found += scan_top_k (markov_chain, nodes[queries[i]]->data, sorted);
+  }
+  printf ("Scan and sort top-%d: %.0fns per query\n", TOP_K,
+          seconds_since (&start) * 1e9 / SCAN_QUERIES_NUM);
+
+  const IndexedSuccessor *successors;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < QUERIES_NUM; i++)
+  {
+    found += top_k_next (index, nodes[queries[i]]->data, TOP_K, &successors);
+  }
+  printf ("Indexed top-%d: %.0fns per query\n", TOP_K,
+          seconds_since (&start) * 1e9 / QUERIES_NUM);
+
+  Completion completions[BEAM_WIDTH];
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < BEAM_QUERIES_NUM; i++)
+  {
+    found += top_completions (index, nodes[queries[i]]->data, BEAM_STEPS,
+                              BEAM_WIDTH, completions);
+  }
+  printf ("Beam search of %d steps, width %d: %.0fns per query\n",
+          BEAM_STEPS, BEAM_WIDTH,
+          seconds_since (&start) * 1e9 / BEAM_QUERIES_NUM);
+  printf ("(%ld results)\n", found);
+  free_markov_index (&index);
+}
+
+/**
+ * @param argc num of arguments
+ * @param argv 1) Seed
+ *             2) Number of words in the vocabulary
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int main (int argc, char *argv[])
+{
+  if (argc - 1 != ARGS_NUM)
+  {
+    printf (ARGS_NUM_ERROR_MESSAGE);
+    return EXIT_FAILURE;
+  }
+  srand ((unsigned int) strtol (argv[SEED_INDEX], NULL, BASE));
+  int words_num = (int) strtol (argv[VOCABULARY_INDEX], NULL, BASE);
+  MarkovChain *markov_chain = calloc (1, sizeof (MarkovChain));
+  MarkovNode **nodes = malloc ((words_num > 0 ? words_num : 1)
+                               * sizeof (MarkovNode *));
+  int *queries = malloc (QUERIES_NUM * sizeof (int));
+  if (!markov_chain || !nodes || !queries || words_num <= 0)
+  {
+    free (markov_chain);
+    free (nodes);
+    free (queries);
+    return EXIT_FAILURE;
+  }
+  markov_chain->copy_func = cpy_func;
+  markov_chain->free_data = free_data_func;
+  markov_chain->comp_func = comp_data;
+  markov_chain->is_last = end_of_sentence;
+  if (fill_database (markov_chain, words_num, nodes) == EXIT_SUCCESS)
+  {
+    for (int i = 0; i < QUERIES_NUM; i++)
+    {
+      queries[i] = skewed_word (words_num);
+    }
+    run_benchmark (markov_chain, nodes, words_num, queries);
+  }
+  free (queries);
+  free (nodes);
+  free_database (&markov_chain);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,365 @@
+#include "corpus_pipeline.h"
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h> // For sysconf()
+
+#define PIPELINE_DEPTH 4
+#define QUEUE_CAPACITY 8 // power of 2, at least PIPELINE_DEPTH
+#define BATCH_LINES 64
+#define PIPELINE_MIN_CPUS 2
+#define SPIN_LIMIT 100 // empty checks before a waiting stage parks
+#define MAX_LINE_WORDS (MAX_SENTENCE / 2)
+#define WORD_DELIMITERS " \n\r"
+
+#define THREAD_ERROR_MESSAGE "Error: failed to start the reading threads.\n"
+
+/**
+ * Up to BATCH_LINES lines of the file, as fgets returns them, and their words.
+ * The words of line i are words[line_end[i - 1]] ... words[line_end[i] - 1].
+ */
+typedef struct Batch {
+    char text[BATCH_LINES][MAX_SENTENCE];
+    int lines;
+    char *words[BATCH_LINES * MAX_LINE_WORDS];
+    int line_end[BATCH_LINES];
+    bool eof; // last batch of the file, no batch follows it
+} Batch;
+
+/**
+ * Single producer, single consumer ring of batches. head is written only by
+ * the consumer and tail only by the producer. The lock and condition are used
+ * only when the consumer finds the ring empty for a while and parks.
+ */
+typedef struct BatchQueue {
+    Batch *slots[QUEUE_CAPACITY];
+    atomic_size_t head;
+    atomic_size_t tail;
+    atomic_int parked; // 1 while the consumer is parked or about to park
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+} BatchQueue;
+
+typedef struct Pipeline {
+    FILE *fp;
+    BatchQueue free_batches; // builder -> reader
+    BatchQueue read_batches; // reader -> tokenizer
+    BatchQueue token_batches; // tokenizer -> builder
+    atomic_bool stop; // set by the builder when it needs no more lines
+} Pipeline;
+
+/**
+ * @return true on success, false if the lock or condition failed to start
+ */
+static bool init_queue (BatchQueue *queue)
+{
+  if (pthread_mutex_init (&queue->lock, NULL))
+  {
+    return false;
+  }
+  if (pthread_cond_init (&queue->not_empty, NULL))
+  {
+    pthread_mutex_destroy (&queue->lock);
+    return false;
+  }
+  return true;
+}
+
+static void destroy_queue (BatchQueue *queue)
+{
+  pthread_cond_destroy (&queue->not_empty);
+  pthread_mutex_destroy (&queue->lock);
+}
+
+/**
+ * Push a batch to the queue and wake the consumer if it is parked. Never
+ * full, since only PIPELINE_DEPTH batches exist.
+ */
+static void push_batch (BatchQueue *queue, Batch *batch)
+{
+  size_t tail = atomic_load_explicit (&queue->tail, memory_order_relaxed);
+  queue->slots[tail % QUEUE_CAPACITY] = batch;
+  // sequentially consistent, so either this sees parked or the consumer sees
+  // the new tail before it sleeps
+  atomic_store (&queue->tail, tail + 1);
+  if (atomic_load (&queue->parked))
+  {
+    pthread_mutex_lock (&queue->lock);
+    pthread_cond_signal (&queue->not_empty);
+    pthread_mutex_unlock (&queue->lock);
+  }
+}
+
+/**
+ * Pop the next batch from the queue. If it is empty, check again a few
+ * times, then sleep until the producer pushes one.
+ */
+static Batch *pop_batch (BatchQueue *queue)
+{
+  size_t head = atomic_load_explicit (&queue->head, memory_order_relaxed);
+  int spin = 0;
+  while (atomic_load_explicit (&queue->tail, memory_order_acquire) == head
+         && spin < SPIN_LIMIT)
+  {
+    spin++;
+  }
+  if (spin == SPIN_LIMIT)
+  {
+    pthread_mutex_lock (&queue->lock);
+    atomic_store (&queue->parked, 1);
+    while (atomic_load (&queue->tail) == head)
+    {
+      pthread_cond_wait (&queue->not_empty, &queue->lock);
+    }
+    atomic_store (&queue->parked, 0);
+    pthread_mutex_unlock (&queue->lock);
+  }
+  Batch *batch = queue->slots[head % QUEUE_CAPACITY];
+  atomic_store_explicit (&queue->head, head + 1, memory_order_release);
+  return batch;
+}
+
+/**
+ * Fill the batch with the next lines of the file.
+ * @return true if the file ended, false if more lines may follow
+ */
+static bool read_batch (FILE *fp, Batch *batch)
+{
+  batch->lines = 0;
+  while (batch->lines < BATCH_LINES
+         && fgets (batch->text[batch->lines], MAX_SENTENCE, fp))
+  {
+    batch->lines++;
+  }
+  batch->eof = batch->lines < BATCH_LINES;
+  return batch->eof;
+}
+
+/**
+ * Split the lines of the batch into words, in place.
+ */
+static void tokenize_batch (Batch *batch)
+{
+  int words_num = 0;
+  for (int line = 0; line < batch->lines; line++)
+  {
+    char *save_ptr = NULL;
+    char *data = strtok_r (batch->text[line], WORD_DELIMITERS, &save_ptr);
+    while (data != NULL)
+    {
+      batch->words[words_num++] = data;
+      data = strtok_r (NULL, WORD_DELIMITERS, &save_ptr);
+    }
+    batch->line_end[line] = words_num;
+  }
+}
+
+static void *reader_stage (void *arg)
+{
+  Pipeline *pipeline = (Pipeline *) arg;
+  bool eof = false;
+  while (!eof)
+  {
+    Batch *batch = pop_batch (&pipeline->free_batches);
+    if (atomic_load_explicit (&pipeline->stop, memory_order_relaxed))
+    {
+      batch->lines = 0;
+      batch->eof = true;
+    }
+    else
+    {
+      read_batch (pipeline->fp, batch);
+    }
+    eof = batch->eof;
+    push_batch (&pipeline->read_batches, batch);
+  }
+  return NULL;
+}
+
+static void *tokenizer_stage (void *arg)
+{
+  Pipeline *pipeline = (Pipeline *) arg;
+  bool eof = false;
+  while (!eof)
+  {
+    Batch *batch = pop_batch (&pipeline->read_batches);
+    tokenize_batch (batch);
+    eof = batch->eof;
+    push_batch (&pipeline->token_batches, batch);
+  }
+  return NULL;
+}
+
+/**
+ * Add the words of the batch to the chain, line by line.
+ * @param words_counter number of the next word to add, 1 for the first one
+ * @return 0 on success, 1 on allocation failure
+ */
+static int build_batch (Batch *batch, int words_to_read, int *words_counter,
+                        MarkovChain *markov_chain)
+{
+  int word = 0;
+  for (int line = 0; line < batch->lines; line++)
+  {
+    Node *previous_node = NULL;
+    for (; word < batch->line_end[line]; word++)
+    {
+      if (words_to_read != READ_ALL_FILE && *words_counter > words_to_read)
+      {
+        return 0;
+      }
+      Node *now_node = add_to_database (markov_chain, batch->words[word]);
+      if (now_node == NULL)
+      {
+        return 1;
+      }
+      if ((previous_node != NULL)
+          && !markov_chain->is_last (previous_node->data->data))
+      {
+        if (!add_node_to_frequencies_list (previous_node->data,
+                                           now_node->data, markov_chain))
+        {
+          return 1;
+        }
+      }
+      previous_node = now_node;
+      (*words_counter)++;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @return true on success, false if a queue failed to start
+ */
+static bool init_queues (Pipeline *pipeline)
+{
+  if (!init_queue (&pipeline->free_batches))
+  {
+    return false;
+  }
+  if (!init_queue (&pipeline->read_batches))
+  {
+    destroy_queue (&pipeline->free_batches);
+    return false;
+  }
+  if (!init_queue (&pipeline->token_batches))
+  {
+    destroy_queue (&pipeline->free_batches);
+    destroy_queue (&pipeline->read_batches);
+    return false;
+  }
+  return true;
+}
+
+static void destroy_queues (Pipeline *pipeline)
+{
+  destroy_queue (&pipeline->free_batches);
+  destroy_queue (&pipeline->read_batches);
+  destroy_queue (&pipeline->token_batches);
+}
+
+/**
+ * Run the three stages one after the other on the calling thread, for hosts
+ * where the stage threads would only take turns on one CPU.
+ * @return 0 on success, 1 on allocation failure
+ */
+static int fill_database_inline (FILE *fp, int words_to_read,
+                                 MarkovChain *markov_chain)
+{
+  Batch *batch = malloc (sizeof (Batch));
+  if (!batch)
+  {
+    printf (ALLOCATION_ERROR_MASSAGE);
+    return 1;
+  }
+  int fill = 0, words_counter = 1;
+  bool eof = false;
+  while (!fill && !eof && (words_to_read == READ_ALL_FILE
+                           || words_counter <= words_to_read))
+  {
+    eof = read_batch (fp, batch);
+    tokenize_batch (batch);
+    fill = build_batch (batch, words_to_read, &words_counter, markov_chain);
+  }
+  free (batch);
+  return fill;
+}
+
+int fill_database_pipelined (FILE *fp, int words_to_read,
+                             MarkovChain *markov_chain)
+{
+  if (sysconf (_SC_NPROCESSORS_ONLN) < PIPELINE_MIN_CPUS)
+  {
+    return fill_database_inline (fp, words_to_read, markov_chain);
+  }
+  Pipeline *pipeline = calloc (1, sizeof (Pipeline));
+  Batch *batches = calloc (PIPELINE_DEPTH, sizeof (Batch));
+  if (!pipeline || !batches)
+  {
+    printf (ALLOCATION_ERROR_MASSAGE);
+    free (pipeline);
+    free (batches);
+    return 1;
+  }
+  pipeline->fp = fp;
+  if (!init_queues (pipeline))
+  {
+    printf (THREAD_ERROR_MESSAGE);
+    free (pipeline);
+    free (batches);
+    return 1;
+  }
+  for (int i = 0; i < PIPELINE_DEPTH; i++)
+  {
+    push_batch (&pipeline->free_batches, batches + i);
+  }
+  pthread_t reader, tokenizer;
+  if (pthread_create (&tokenizer, NULL, tokenizer_stage, pipeline))
+  {
+    printf (THREAD_ERROR_MESSAGE);
+    destroy_queues (pipeline);
+    free (pipeline);
+    free (batches);
+    return 1;
+  }
+  if (pthread_create (&reader, NULL, reader_stage, pipeline))
+  {
+    // stand in for the reader, so the tokenizer sees the end of the file
+    Batch *batch = pop_batch (&pipeline->free_batches);
+    batch->lines = 0;
+    batch->eof = true;
+    push_batch (&pipeline->read_batches, batch);
+    pthread_join (tokenizer, NULL);
+    printf (THREAD_ERROR_MESSAGE);
+    destroy_queues (pipeline);
+    free (pipeline);
+    free (batches);
+    return 1;
+  }
+
+  int fill = 0, words_counter = 1;
+  bool eof = false;
+  while (!eof)
+  {
+    Batch *batch = pop_batch (&pipeline->token_batches);
+    if (!atomic_load_explicit (&pipeline->stop, memory_order_relaxed))
+    {
+      fill = build_batch (batch, words_to_read, &words_counter, markov_chain);
+      if (fill || (words_to_read != READ_ALL_FILE
+                   && words_counter > words_to_read))
+      {
+        // keep draining until the reader's last batch arrives
+        atomic_store_explicit (&pipeline->stop, true, memory_order_relaxed);
+      }
+    }
+    eof = batch->eof;
+    push_batch (&pipeline->free_batches, batch);
+  }
+  pthread_join (reader, NULL);
+  pthread_join (tokenizer, NULL);
+  destroy_queues (pipeline);
+  free (pipeline);
+  free (batches);
+  return fill;
+}
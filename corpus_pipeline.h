@@ -0,0 +1,29 @@
+#ifndef _CORPUS_PIPELINE_H
+#define _CORPUS_PIPELINE_H
+
+#include "markov_chain.h"
+
+#define MAX_SENTENCE 1000
+#define READ_ALL_FILE (-1)
+
+/**
+ * Fill markov_chain with the words of the given file. Reading, tokenizing and
+ * adding to the chain run as three threads joined by bounded lock-free
+ * queues, and the words are added in file order, so the resulting chain is the
+ * same as reading the file line by line with fgets and strtok. A stage with
+ * nothing to do sleeps instead of spinning, and on a single CPU the stages run
+ * one after the other on the calling thread.
+ * A word that ends a sentence (markov_chain->is_last) is not linked to the
+ * next one, and words on different lines are never linked.
+ * The builder stage runs add_to_database, which scans the whole database for
+ * every word, so it bounds the speed; reading and tokenizing can at most hide
+ * their own few percent of the time behind it.
+ * @param fp file to read the words from
+ * @param words_to_read maximal number of words to add, READ_ALL_FILE for all
+ * @param markov_chain the chain to fill
+ * @return 0 on success, 1 on allocation or thread failure
+ */
+int fill_database_pipelined (FILE *fp, int words_to_read,
+                             MarkovChain *markov_chain);
+
+#endif /* _CORPUS_PIPELINE_H */
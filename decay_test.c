@@ -0,0 +1,161 @@
+#include <string.h>
+#include "markov_chain.h"
+
+#define HALF_LIFE 200
+#define SENTENCES_NUM 200000
+#define SENTENCE_WORDS 4
+#define WORDS_PER_TOPIC 50
+#define SENTENCES_PER_TOPIC 1000
+#define WARMUP_SENTENCES (SENTENCES_NUM / 4)
+#define MAX_WORD 32
+
+static bool end_of_sentence (void *data)
+{
+  char *string_data = (char *) data;
+  return !strcmp (&string_data[strlen (string_data) - 1], ".");
+}
+
+static int comp_data (void *first, void *second)
+{
+  return strcmp ((char *) first, (char *) second);
+}
+
+static void *cpy_func (void *data)
+{
+  char *string_data = (char *) data;
+  char *new_data = calloc (1, strlen (string_data) + 1);
+  if (new_data)
+  {
+    strcpy (new_data, string_data);
+  }
+  return (void *) new_data;
+}
+
+static void free_data_func (void *data)
+{
+  free (data);
+}
+
+/**
+ * Check that every node's in_degree is the number of entries pointing to it.
+ * @return true if all the counts match
+ */
+static bool check_in_degrees (MarkovChain *markov_chain)
+{
+  Node *node, *other;
+  for (node = markov_chain->database->first; node; node = node->next)
+  {
+    int in_degree = 0;
+    for (other = markov_chain->database->first; other; other = other->next)
+    {
+      for (int index = 0; index < other->data->follow_num; index++)
+      {
+        in_degree += other->data->frequencies_list[index].markov_node
+                     == node->data;
+      }
+    }
+    if (in_degree != node->data->in_degree)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @return true if first has a transition to second
+ */
+static bool has_transition (MarkovNode *first, MarkovNode *second)
+{
+  for (int index = 0; index < first->follow_num; index++)
+  {
+    if (first->frequencies_list[index].markov_node == second)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Add one sentence of words from the current topic, calling decay_database
+ * after every word as the README suggests, and check that the transition
+ * linked right before each call survives it.
+ * @return true on success, false in case of allocation error or lost
+ * transition
+ */
+static bool add_sentence (MarkovChain *markov_chain, DecayWindow *window,
+                          int sentence)
+{
+  char word[MAX_WORD];
+  int topic = sentence / SENTENCES_PER_TOPIC;
+  Node *previous_node = NULL;
+  for (int i = 0; i < SENTENCE_WORDS; i++)
+  {
+    snprintf (word, MAX_WORD, (i == SENTENCE_WORDS - 1) ? "w%d." : "w%d",
+              topic * WORDS_PER_TOPIC + rand () % WORDS_PER_TOPIC);
+    Node *now_node = add_to_database (markov_chain, word);
+    if (!now_node
+        || (previous_node && !add_node_to_frequencies_list (
+            previous_node->data, now_node->data, markov_chain)))
+    {
+      printf (ALLOCATION_ERROR_MASSAGE);
+      return false;
+    }
+    decay_database (markov_chain, window);
+    if (previous_node && !has_transition (previous_node->data, now_node->data))
+    {
+      printf ("transition to %s lost by the next decay\n", word);
+      return false;
+    }
+    previous_node = now_node;
+  }
+  return true;
+}
+
+int main (void)
+{
+  MarkovChain *markov_chain = calloc (1, sizeof (MarkovChain));
+  if (!markov_chain)
+  {
+    return EXIT_FAILURE;
+  }
+  markov_chain->copy_func = cpy_func;
+  markov_chain->free_data = free_data_func;
+  markov_chain->comp_func = comp_data;
+  markov_chain->is_last = end_of_sentence;
+  DecayWindow window;
+  init_decay_window (&window, HALF_LIFE);
+  srand (1);
+  int warmup_max = 0, max_size = 0, result = EXIT_SUCCESS;
+  for (int sentence = 0; sentence < SENTENCES_NUM; sentence++)
+  {
+    if (!add_sentence (markov_chain, &window, sentence))
+    {
+      result = EXIT_FAILURE;
+      break;
+    }
+    int size = markov_chain->database->size;
+    if (sentence < WARMUP_SENTENCES)
+    {
+      warmup_max = (size > warmup_max) ? size : warmup_max;
+    }
+    max_size = (size > max_size) ? size : max_size;
+    if (sentence % SENTENCES_PER_TOPIC == 0 && !check_in_degrees (markov_chain))
+    {
+      printf ("in_degree mismatch after sentence %d\n", sentence);
+      result = EXIT_FAILURE;
+      break;
+    }
+  }
+  // the vocabulary keeps moving to new words, the database must not follow
+  if (result == EXIT_SUCCESS && max_size > 2 * warmup_max)
+  {
+    printf ("database grew from %d to %d states\n", warmup_max, max_size);
+    result = EXIT_FAILURE;
+  }
+  printf ("%s: at most %d states, %d after warmup\n",
+          result == EXIT_SUCCESS ? "PASS" : "FAIL", max_size, warmup_max);
+  free_database (&markov_chain);
+  return result;
+}
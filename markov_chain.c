@@ -4,11 +4,15 @@
 Node *add_to_database (MarkovChain *markov_chain, void *data_ptr)
 {
   Node *node = get_node_from_database (markov_chain, data_ptr);
+  if (!node)
+  {
+    node = new_node (markov_chain, data_ptr);
+  }
   if (node)
   {
-    return node;
+    node->data->touched = true;
   }
-  return new_node (markov_chain, data_ptr);
+  return node;
 }
 
 Node *new_node (MarkovChain *markov_chain, void *data_ptr)
@@ -28,6 +32,10 @@ Node *new_node (MarkovChain *markov_chain, void *data_ptr)
   markov_node->frequencies_list = NULL;
   markov_node->follow_num = 0;
   markov_node->mnodef_capacity = 0;
+  markov_node->in_degree = 0;
+  markov_node->touched = false;
+  markov_node->reach_lengths = 0;
+  markov_node->last_distance = -1;
   if (!markov_chain->database)
   {
     markov_chain->database = get_database ();
@@ -87,6 +95,7 @@ bool add_node_to_frequencies_list (MarkovNode *first_node, MarkovNode
                                   second_node->data))
     {
       (first_node->frequencies_list + index)->frequency++;
+      (first_node->frequencies_list + index)->weight += 1 << DECAY_SHIFT;
       return true;
     }
   }
@@ -105,7 +114,10 @@ bool add_node_to_frequencies_list (MarkovNode *first_node, MarkovNode
   first_node->frequencies_list[first_node->follow_num].markov_node =
       second_node;
   first_node->frequencies_list[first_node->follow_num].frequency = 1;
+  first_node->frequencies_list[first_node->follow_num].weight =
+      1 << DECAY_SHIFT;
   first_node->follow_num++;
+  second_node->in_degree++;
   return true;
 }
 
@@ -173,13 +185,26 @@ MarkovNode *get_first_random_node (MarkovChain *markov_chain) //checked
   return curr_node->data;
 }
 
-MarkovNode *get_next_random_node (MarkovNode *state_struct_ptr) //checked
+/**
+ * @return sum of the frequencies of the node's followers.
+ */
+static int get_follow_weight (MarkovNode *state_struct_ptr)
 {
   int words_num = 0;
   for (int index = 0; index < state_struct_ptr->follow_num; index++)
   {
     words_num += (state_struct_ptr->frequencies_list + index)->frequency;
   }
+  return words_num;
+}
+
+/**
+ * Choose randomly the next state, given the sum of the followers'
+ * frequencies.
+ */
+static MarkovNode *pick_next_node (MarkovNode *state_struct_ptr,
+                                   int words_num)
+{
   if (!words_num)
   {
     return NULL;
@@ -199,26 +224,429 @@ MarkovNode *get_next_random_node (MarkovNode *state_struct_ptr) //checked
   return NULL;
 }
 
+MarkovNode *get_next_random_node (MarkovNode *state_struct_ptr) //checked
+{
+  return pick_next_node (state_struct_ptr,
+                         get_follow_weight (state_struct_ptr));
+}
+
+void walk_init (MarkovWalk *walk, MarkovChain *markov_chain,
+                MarkovNode *first_node, int max_length)
+{
+  walk->markov_chain = markov_chain;
+  walk->curr_node = first_node;
+  walk->length = 0;
+  walk->max_length = max_length;
+  walk->follow_weight = 0;
+  walk->done = max_length < 1;
+}
+
+MarkovNode *walk_next (MarkovWalk *walk)
+{
+  if (walk->done)
+  {
+    return NULL;
+  }
+  if (!walk->length)
+  {
+    if (!walk->curr_node)
+    {
+      walk->curr_node = get_first_random_node (walk->markov_chain);
+    }
+  }
+  else
+  {
+    walk->curr_node = pick_next_node (walk->curr_node, walk->follow_weight);
+  }
+  walk->length++;
+  walk->done = walk->length >= walk->max_length
+               || walk->markov_chain->is_last (walk->curr_node->data);
+  if (!walk->done)
+  {
+    // pick_next_node returns NULL exactly when no follower has weight
+    walk->follow_weight = get_follow_weight (walk->curr_node);
+    walk->done = !walk->follow_weight;
+  }
+  return walk->curr_node;
+}
+
+bool walk_done (const MarkovWalk *walk)
+{
+  return walk->done;
+}
+
 void generate_tweet (MarkovChain *markov_chain, MarkovNode *  //checked
 first_node, int max_length)
 {
+  MarkovWalk walk;
+  walk_init (&walk, markov_chain, first_node, max_length);
+  while (!walk_done (&walk))
+  {
+    markov_chain->print_func (walk_next (&walk)->data);
+  }
+}
+
+/**
+ * Fill last_distance of every node with a breadth first search from the last
+ * states along the reversed transitions, in O(nodes + transitions).
+ * @return true on success, false in case of allocation error
+ */
+static bool compute_last_distances (MarkovChain *markov_chain)
+{
+  int nodes_num = 0;
+  Node *curr_node;
+  for (curr_node = markov_chain->database->first; curr_node;
+       curr_node = curr_node->next)
+  {
+    // the node's number, until the search overwrites it
+    curr_node->data->last_distance = nodes_num++;
+  }
+  MarkovNode **nodes = malloc ((nodes_num + 1) * sizeof (MarkovNode *));
+  int *first_pred = calloc (nodes_num + 1, sizeof (int));
+  int *queue = malloc ((nodes_num + 1) * sizeof (int));
+  int *distance = malloc ((nodes_num + 1) * sizeof (int));
+  int preds_num = 0;
+  for (curr_node = markov_chain->database->first; curr_node;
+       curr_node = curr_node->next)
+  {
+    preds_num += curr_node->data->follow_num;
+  }
+  int *preds = malloc ((preds_num + 1) * sizeof (int));
+  if (!nodes || !first_pred || !queue || !distance || !preds)
+  {
+    printf (ALLOCATION_ERROR_MASSAGE);
+    free (nodes);
+    free (first_pred);
+    free (queue);
+    free (distance);
+    free (preds);
+    return false;
+  }
+  // reversed transitions: the predecessors of node v are
+  // preds[first_pred[v]] ... preds[first_pred[v + 1] - 1]
+  int queue_end = 0;
+  for (curr_node = markov_chain->database->first; curr_node;
+       curr_node = curr_node->next)
+  {
+    MarkovNode *markov_node = curr_node->data;
+    nodes[markov_node->last_distance] = markov_node;
+    distance[markov_node->last_distance] = -1;
+    if (markov_chain->is_last (markov_node->data))
+    {
+      // a walk stops at a last state, so its followers do not count
+      distance[markov_node->last_distance] = 1;
+      queue[queue_end++] = markov_node->last_distance;
+      continue;
+    }
+    for (int index = 0; index < markov_node->follow_num; index++)
+    {
+      first_pred[markov_node->frequencies_list[index].markov_node
+                     ->last_distance + 1]++;
+    }
+  }
+  for (int v = 0; v < nodes_num; v++)
+  {
+    first_pred[v + 1] += first_pred[v];
+  }
+  for (int u = 0; u < nodes_num; u++)
+  {
+    if (distance[u] == 1)
+    {
+      continue;
+    }
+    for (int index = 0; index < nodes[u]->follow_num; index++)
+    {
+      int v = nodes[u]->frequencies_list[index].markov_node->last_distance;
+      // first_pred[v] is used as the next free place while filling
+      preds[first_pred[v]++] = u;
+    }
+  }
+  // the filling moved every first_pred[v] to the start of v + 1
+  for (int v = nodes_num; v > 0; v--)
+  {
+    first_pred[v] = first_pred[v - 1];
+  }
+  first_pred[0] = 0;
+  for (int queue_start = 0; queue_start < queue_end; queue_start++)
+  {
+    int v = queue[queue_start];
+    for (int index = first_pred[v]; index < first_pred[v + 1]; index++)
+    {
+      int u = preds[index];
+      if (distance[u] < 0)
+      {
+        distance[u] = distance[v] + 1;
+        queue[queue_end++] = u;
+      }
+    }
+  }
+  for (int v = 0; v < nodes_num; v++)
+  {
+    nodes[v]->last_distance = distance[v];
+  }
+  free (nodes);
+  free (first_pred);
+  free (queue);
+  free (distance);
+  free (preds);
+  return true;
+}
+
+bool compute_reachability (MarkovChain *markov_chain)
+{
+  if (!markov_chain->database)
+  {
+    return true;
+  }
+  Node *curr_node;
+  for (curr_node = markov_chain->database->first; curr_node;
+       curr_node = curr_node->next)
+  {
+    bool last = markov_chain->is_last (curr_node->data->data);
+    curr_node->data->reach_lengths = last ? 1ULL << 1 : 0;
+  }
+  // walks of length k are built from the walks of length k - 1 of the
+  // followers; once no node has a walk of length k, none has a longer one
+  bool found = true;
+  for (int length = 2; length <= MAX_REACH_LENGTH && found; length++)
+  {
+    found = false;
+    for (curr_node = markov_chain->database->first; curr_node;
+         curr_node = curr_node->next)
+    {
+      MarkovNode *markov_node = curr_node->data;
+      if (markov_chain->is_last (markov_node->data))
+      {
+        continue;
+      }
+      for (int index = 0; index < markov_node->follow_num; index++)
+      {
+        if (markov_node->frequencies_list[index].markov_node->reach_lengths
+            & (1ULL << (length - 1)))
+        {
+          markov_node->reach_lengths |= 1ULL << length;
+          found = true;
+          break;
+        }
+      }
+    }
+  }
+  return compute_last_distances (markov_chain);
+}
+
+/**
+ * Get the lengths in [min_length, max_length], shifted down by skip, as a
+ * reach_lengths mask.
+ */
+static unsigned long long lengths_in_range (int min_length, int max_length,
+                                            int skip)
+{
+  unsigned long long range = (2ULL << max_length) - 1;
+  range &= ~((1ULL << min_length) - 1);
+  return range >> skip;
+}
+
+/**
+ * Choose randomly, by frequency, one of the followers of the given node that
+ * has a walk with a length in the given mask.
+ * @return the chosen MarkovNode, NULL if no follower fits.
+ */
+static MarkovNode *get_next_bounded_node (MarkovNode *state_struct_ptr,
+                                          unsigned long long lengths)
+{
+  int words_num = 0;
+  for (int index = 0; index < state_struct_ptr->follow_num; index++)
+  {
+    MarkovNodeFrequency *curr_f = state_struct_ptr->frequencies_list + index;
+    if (curr_f->markov_node->reach_lengths & lengths)
+    {
+      words_num += curr_f->frequency;
+    }
+  }
+  if (!words_num)
+  {
+    return NULL;
+  }
+  int new_index = get_random_number (words_num);
+  for (int index = 0; index < state_struct_ptr->follow_num; index++)
+  {
+    MarkovNodeFrequency *curr_f = state_struct_ptr->frequencies_list + index;
+    if (curr_f->markov_node->reach_lengths & lengths)
+    {
+      new_index -= curr_f->frequency;
+      if (new_index < 0)
+      {
+        return curr_f->markov_node;
+      }
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Choose uniformly one node of the database that has a walk with a length in
+ * the given mask. A last state has only the walk of length 1.
+ * @return the chosen MarkovNode, NULL if no node fits.
+ */
+static MarkovNode *get_first_bounded_node (MarkovChain *markov_chain,
+                                           unsigned long long lengths)
+{
+  int words_num = 0;
+  Node *curr_node;
+  for (curr_node = markov_chain->database->first; curr_node;
+       curr_node = curr_node->next)
+  {
+    if (curr_node->data->reach_lengths & lengths)
+    {
+      words_num++;
+    }
+  }
+  if (!words_num)
+  {
+    return NULL;
+  }
+  int new_index = get_random_number (words_num);
+  for (curr_node = markov_chain->database->first; curr_node;
+       curr_node = curr_node->next)
+  {
+    if ((curr_node->data->reach_lengths & lengths) && !new_index--)
+    {
+      return curr_node->data;
+    }
+  }
+  return NULL;
+}
+
+bool generate_bounded_tweet (MarkovChain *markov_chain, MarkovNode *first_node,
+                             int min_length, int max_length)
+{
+  if (!markov_chain->database || min_length < 1 || min_length > max_length
+      || max_length > MAX_REACH_LENGTH)
+  {
+    return false;
+  }
   if (!first_node)
   {
-    first_node = get_first_random_node (markov_chain);
+    first_node = get_first_bounded_node (
+        markov_chain, lengths_in_range (min_length, max_length, 0));
+  }
+  // the nearest last state must not be too far, and then the mask decides
+  if (!first_node || first_node->last_distance < 0
+      || first_node->last_distance > max_length
+      || !(first_node->reach_lengths
+           & lengths_in_range (min_length, max_length, 0)))
+  {
+    return false;
   }
   MarkovNode *next_node = first_node;
-  for (int index = 1; index <= max_length; index++)
+  for (int index = 1; !markov_chain->is_last (next_node->data); index++)
+  {
+    markov_chain->print_func (next_node->data);
+    next_node = get_next_bounded_node (
+        next_node, lengths_in_range (min_length, max_length, index));
+  }
+  markov_chain->print_func (next_node->data);
+  return true;
+}
+
+void init_decay_window (DecayWindow *window, int half_life)
+{
+  window->half_life = half_life;
+  window->cursor = NULL;
+  window->previous = NULL;
+}
+
+/**
+ * Halve every weight of the given node, remove the transitions whose weight
+ * dropped to zero and shrink the list to its new size.
+ * @param markov_node the node to decay.
+ */
+static void decay_node (MarkovNode *markov_node)
+{
+  int kept = 0;
+  for (int index = 0; index < markov_node->follow_num; index++)
   {
-    if (!next_node)
+    MarkovNodeFrequency curr_f = markov_node->frequencies_list[index];
+    curr_f.weight >>= 1;
+    curr_f.frequency = (curr_f.weight + (1 << DECAY_SHIFT) - 1) >> DECAY_SHIFT;
+    if (curr_f.weight)
     {
-      return;
+      markov_node->frequencies_list[kept] = curr_f;
+      kept++;
+    }
+    else
+    {
+      curr_f.markov_node->in_degree--;
+    }
+  }
+  markov_node->follow_num = kept;
+  if (!kept)
+  {
+    free (markov_node->frequencies_list);
+    markov_node->frequencies_list = NULL;
+    markov_node->mnodef_capacity = 0;
+  }
+  else if (kept < markov_node->mnodef_capacity)
+  {
+    MarkovNodeFrequency *shrunk = realloc (markov_node->frequencies_list,
+                                           kept * sizeof (MarkovNodeFrequency));
+    if (shrunk)
+    {
+      markov_node->frequencies_list = shrunk;
+      markov_node->mnodef_capacity = kept;
+    }
+  }
+}
+
+void decay_database (MarkovChain *markov_chain, DecayWindow *window)
+{
+  if (!markov_chain->database || !markov_chain->database->first)
+  {
+    return;
+  }
+  // never more than one visit per node, so a node touched before this call
+  // is not evicted by it
+  int budget = markov_chain->database->size / window->half_life + 1;
+  if (budget > markov_chain->database->size)
+  {
+    budget = markov_chain->database->size;
+  }
+  for (int step = 0; step < budget; step++)
+  {
+    if (!window->cursor)
+    {
+      window->cursor = markov_chain->database->first;
+      window->previous = NULL;
     }
-    if (markov_chain->is_last (next_node->data) || index == max_length)
+    if (!window->cursor)
     {
-      markov_chain->print_func (next_node->data);
       return;
     }
-    markov_chain->print_func (next_node->data);
-    next_node = get_next_random_node (next_node);
+    Node *curr_node = window->cursor, *next_node = curr_node->next;
+    decay_node (curr_node->data);
+    bool touched = curr_node->data->touched;
+    curr_node->data->touched = false;
+    if (touched || curr_node->data->follow_num || curr_node->data->in_degree)
+    {
+      window->previous = curr_node;
+    }
+    else
+    {
+      if (window->previous)
+      {
+        window->previous->next = next_node;
+      }
+      else
+      {
+        markov_chain->database->first = next_node;
+      }
+      if (markov_chain->database->last == curr_node)
+      {
+        markov_chain->database->last = window->previous;
+      }
+      markov_chain->database->size--;
+      free_node (curr_node, markov_chain);
+    }
+    window->cursor = next_node;
   }
-}
\ No newline at end of file
+}
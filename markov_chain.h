@@ -8,6 +8,9 @@
 
 #define ALLOCATION_ERROR_MASSAGE "Allocation failure: Failed to allocate new memory\n"
 
+#define MAX_REACH_LENGTH 63
+#define DECAY_SHIFT 4
+
 
 /***************************/
 /*   insert typedefs here  */
@@ -32,11 +35,24 @@ typedef struct MarkovNode {
     struct MarkovNodeFrequency *frequencies_list;
     int follow_num;
     int mnodef_capacity;
+    int in_degree; // number of frequencies_list entries pointing to this node
+    // returned by add_to_database since decay_database last visited it
+    bool touched;
+    // filled by compute_reachability:
+    // bit k is set if a walk of k states from this node can end in a last
+    // state, for k up to MAX_REACH_LENGTH
+    unsigned long long reach_lengths;
+    // fewest states of a walk from this node to a last state, at any length;
+    // -1 if no walk reaches one (dead end)
+    int last_distance;
 } MarkovNode;
 
 typedef struct MarkovNodeFrequency {
     MarkovNode *markov_node;
     int frequency;
+    // frequency in units of 1 / 2^DECAY_SHIFT, halved by decay_database;
+    // frequency is this rounded up
+    int weight;
 } MarkovNodeFrequency;
 
 /* DO NOT ADD or CHANGE variable names in this struct */
@@ -67,6 +83,36 @@ typedef struct MarkovChain {
     is_last is_last;
 } MarkovChain;
 
+/**
+ * A walk over the chain, consumed one state at a time with walk_next. It holds
+ * no allocated memory, so any number of walks can be kept and advanced in
+ * turns. Each random choice is made by the walk_next that returns it, so a
+ * walk stopped early or interleaved with others draws nothing ahead.
+ */
+typedef struct MarkovWalk {
+    MarkovChain *markov_chain;
+    // last state returned, before the first walk_next the state to start with
+    // (NULL for a random one)
+    MarkovNode *curr_node;
+    int length; // number of states returned so far
+    int max_length;
+    int follow_weight; // sum of the frequencies of curr_node's followers
+    bool done; // no state is left, worked out by the last walk_next
+} MarkovWalk;
+
+/**
+ * Sliding window over the database used by decay_database. Every weight
+ * in the chain is halved once per sweep, and a sweep is spread over at most
+ * half_life calls, so old transitions fade out instead of piling up.
+ * A transition seen once lives DECAY_SHIFT + 1 halvings, so at least
+ * DECAY_SHIFT full sweeps wherever the cursor is when it is added.
+ */
+typedef struct DecayWindow {
+    int half_life; // number of decay_database calls per sweep
+    Node *cursor; // next database node to decay, NULL to start a new sweep
+    Node *previous; // node before cursor, NULL if cursor is the first one
+} DecayWindow;
+
 /**
  * Get one random state from the given markov_chain's database.
  * @param markov_chain
@@ -91,6 +137,29 @@ MarkovNode* get_next_random_node(MarkovNode *state_struct_ptr);
 void generate_tweet(MarkovChain *markov_chain, MarkovNode *
 first_node, int max_length);
 
+/**
+ * Start a walk, making the same choices generate_tweet makes.
+ * @param walk the walk to initialize
+ * @param markov_chain
+ * @param first_node markov_node to start with, if NULL- choose a random markov_node
+ * @param max_length maximum length of chain to generate
+ */
+void walk_init (MarkovWalk *walk, MarkovChain *markov_chain,
+                MarkovNode *first_node, int max_length);
+
+/**
+ * Choose and get the next state of the walk.
+ * @param walk initialized walk
+ * @return the next state, NULL if the walk is done
+ */
+MarkovNode *walk_next (MarkovWalk *walk);
+
+/**
+ * @param walk initialized walk
+ * @return true if walk_next has no more states to return, false otherwise
+ */
+bool walk_done (const MarkovWalk *walk);
+
 /**
  * Free markov_chain and all of it's content from memory
  * @param markov_chain markov_chain to free
@@ -150,4 +219,52 @@ void free_node (Node *node, MarkovChain *markov_chain);
  */
 Node* add_to_database(MarkovChain *markov_chain, void *data_ptr);
 
+/**
+ * Initialize window to sweep the database once per half_life calls.
+ * @param window the window to initialize
+ * @param half_life number of decay_database calls between two halvings of
+ * the same frequency, must be positive
+ */
+void init_decay_window (DecayWindow *window, int half_life);
+
+/**
+ * Advance the window by one step: halve the weights of the next few nodes
+ * of the current sweep, drop the transitions that reached zero, and evict the
+ * states left with no transitions in or out. A state that still has incoming
+ * transitions is kept until they decay too. Meant to be called once per
+ * insertion. A node returned by add_to_database is never evicted by the next
+ * call, so it can still be linked after it; other MarkovNode pointers must not
+ * be kept across calls.
+ * @param markov_chain the chain to decay
+ * @param window the window state, initialized by init_decay_window
+ */
+void decay_database (MarkovChain *markov_chain, DecayWindow *window);
+
+/**
+ * Record for every node of the chain the lengths of the walks from it that end
+ * in a last state, up to MAX_REACH_LENGTH states, and its exact distance to
+ * the nearest last state. A node with no such walk is a dead end. Must be
+ * called again after the chain changes.
+ * @param markov_chain the chain to scan
+ * @return true on success, false in case of allocation error
+ */
+bool compute_reachability (MarkovChain *markov_chain);
+
+/**
+ * Like generate_tweet, but only walks that end in a last state after
+ * min_length to max_length states are possible: every step is drawn, by
+ * frequency, among the followers that can still finish in that range, so
+ * no output is thrown away. compute_reachability must be up to date.
+ * @param markov_chain
+ * @param first_node markov_node to start with, if NULL- choose a random
+ * markov_node that can start such a walk (a last state alone if min_length
+ * is 1)
+ * @param min_length minimal length of chain to generate, at least 1
+ * @param max_length maximal length of chain to generate, at most
+ * MAX_REACH_LENGTH
+ * @return true if a walk was printed, false if no walk fits the range
+ */
+bool generate_bounded_tweet (MarkovChain *markov_chain, MarkovNode *first_node,
+                             int min_length, int max_length);
+
 #endif /* MARKOV_CHAIN_H */
@@ -0,0 +1,263 @@
+#include "markov_index.h"
+#include <string.h>
+
+/**
+ * Compare two frequencies for qsort, the higher one first.
+ */
+static int comp_frequency (const void *first, const void *second)
+{
+  const MarkovNodeFrequency *first_f = first;
+  const MarkovNodeFrequency *second_f = second;
+  return (second_f->frequency > first_f->frequency)
+         - (second_f->frequency < first_f->frequency);
+}
+
+/**
+ * Find the slot of the given state in the hash table.
+ * @return the slot holding the state, or the empty slot it belongs in
+ */
+static IndexSlot *find_slot (const MarkovIndex *index, void *data_ptr)
+{
+  unsigned long hash = index->hash_func (data_ptr);
+  unsigned long slot = hash & index->table_mask;
+  while (index->table[slot].node
+         && (index->table[slot].hash != hash
+             || index->markov_chain->comp_func (index->table[slot].node->data,
+                                                data_ptr)))
+  {
+    slot = (slot + 1) & index->table_mask;
+  }
+  return index->table + slot;
+}
+
+/**
+ * Fill the successors of every node, sorted by frequency.
+ * @return true on success, false in case of allocation error
+ */
+static bool fill_successors (MarkovIndex *index, int successors_num,
+                             int max_follow_num)
+{
+  index->successors = malloc ((successors_num ? successors_num : 1)
+                              * sizeof (IndexedSuccessor));
+  MarkovNodeFrequency *sorted = malloc ((max_follow_num ? max_follow_num : 1)
+                                        * sizeof (MarkovNodeFrequency));
+  if (!index->successors || !sorted)
+  {
+    free (sorted);
+    return false;
+  }
+  IndexedSuccessor *next_successor = index->successors;
+  for (int i = 0; i < index->nodes_num; i++)
+  {
+    IndexedNode *node = index->nodes + i;
+    MarkovNode *markov_node = node->markov_node;
+    int total = 0;
+    if (markov_node->follow_num)
+    {
+      memcpy (sorted, markov_node->frequencies_list,
+              markov_node->follow_num * sizeof (MarkovNodeFrequency));
+    }
+    qsort (sorted, markov_node->follow_num, sizeof (MarkovNodeFrequency),
+           comp_frequency);
+    for (int j = 0; j < markov_node->follow_num; j++)
+    {
+      total += sorted[j].frequency;
+    }
+    node->successors = next_successor;
+    node->successors_num = markov_node->follow_num;
+    for (int j = 0; j < markov_node->follow_num; j++)
+    {
+      next_successor->node = find_slot (index,
+                                        sorted[j].markov_node->data)->node;
+      next_successor->probability = (double) sorted[j].frequency / total;
+      next_successor++;
+    }
+  }
+  free (sorted);
+  return true;
+}
+
+MarkovIndex *build_markov_index (MarkovChain *markov_chain,
+                                 hash_function hash_func)
+{
+  MarkovIndex *index = calloc (1, sizeof (MarkovIndex));
+  if (!index)
+  {
+    printf (ALLOCATION_ERROR_MASSAGE);
+    return NULL;
+  }
+  index->markov_chain = markov_chain;
+  index->hash_func = hash_func;
+  int successors_num = 0, max_follow_num = 0;
+  Node *curr_node = markov_chain->database ? markov_chain->database->first
+                                           : NULL;
+  for (; curr_node; curr_node = curr_node->next)
+  {
+    index->nodes_num++;
+    successors_num += curr_node->data->follow_num;
+    if (curr_node->data->follow_num > max_follow_num)
+    {
+      max_follow_num = curr_node->data->follow_num;
+    }
+  }
+  // keep the table at most half full
+  unsigned long table_size = 2;
+  while (table_size < 2UL * index->nodes_num)
+  {
+    table_size *= 2;
+  }
+  index->table_mask = table_size - 1;
+  index->nodes = malloc ((index->nodes_num ? index->nodes_num : 1)
+                         * sizeof (IndexedNode));
+  index->table = calloc (table_size, sizeof (IndexSlot));
+  if (!index->nodes || !index->table)
+  {
+    printf (ALLOCATION_ERROR_MASSAGE);
+    free_markov_index (&index);
+    return NULL;
+  }
+  curr_node = markov_chain->database ? markov_chain->database->first : NULL;
+  for (int i = 0; curr_node; curr_node = curr_node->next, i++)
+  {
+    index->nodes[i].markov_node = curr_node->data;
+    index->nodes[i].data = curr_node->data->data;
+    IndexSlot *slot = find_slot (index, curr_node->data->data);
+    slot->hash = hash_func (curr_node->data->data);
+    slot->node = index->nodes + i;
+  }
+  if (!fill_successors (index, successors_num, max_follow_num))
+  {
+    printf (ALLOCATION_ERROR_MASSAGE);
+    free_markov_index (&index);
+    return NULL;
+  }
+  return index;
+}
+
+const IndexedNode *index_lookup (const MarkovIndex *index, void *data_ptr)
+{
+  return find_slot (index, data_ptr)->node;
+}
+
+int top_k_next (const MarkovIndex *index, void *data_ptr, int k,
+                const IndexedSuccessor **successors)
+{
+  const IndexedNode *node = index_lookup (index, data_ptr);
+  if (!node || k <= 0)
+  {
+    return 0;
+  }
+  *successors = node->successors;
+  return (node->successors_num < k) ? node->successors_num : k;
+}
+
+/**
+ * Insert a completion into beam, kept sorted by probability, if it is more
+ * probable than the least probable one of a full beam.
+ */
+static void insert_completion (Completion *beam, int *beam_num,
+                               int beam_width, const Completion *completion)
+{
+  int position = *beam_num;
+  if (position == beam_width)
+  {
+    if (beam[position - 1].probability >= completion->probability)
+    {
+      return;
+    }
+    position--;
+  }
+  else
+  {
+    (*beam_num)++;
+  }
+  while (position > 0
+         && beam[position - 1].probability < completion->probability)
+  {
+    beam[position] = beam[position - 1];
+    position--;
+  }
+  beam[position] = *completion;
+}
+
+/**
+ * @return true if the completion can not be continued.
+ */
+static bool is_finished (const MarkovIndex *index, const IndexedNode *start,
+                         const Completion *completion)
+{
+  if (!completion->length)
+  {
+    return !start->successors_num;
+  }
+  const IndexedNode *tail = completion->path[completion->length - 1];
+  return !tail->successors_num
+         || index->markov_chain->is_last (tail->markov_node->data);
+}
+
+int top_completions (const MarkovIndex *index, void *data_ptr, int steps,
+                     int beam_width, Completion *completions)
+{
+  const IndexedNode *start = index_lookup (index, data_ptr);
+  if (!start || steps <= 0 || beam_width <= 0)
+  {
+    return 0;
+  }
+  steps = (steps < MAX_COMPLETION_STEPS) ? steps : MAX_COMPLETION_STEPS;
+  beam_width = (beam_width < MAX_BEAM_WIDTH) ? beam_width : MAX_BEAM_WIDTH;
+  Completion beams[2][MAX_BEAM_WIDTH];
+  Completion *beam = beams[0], *next_beam = beams[1];
+  int beam_num = 1, next_beam_num;
+  beam[0].length = 0;
+  beam[0].probability = 1;
+  for (int step = 0; step < steps; step++)
+  {
+    bool extended = false;
+    next_beam_num = 0;
+    for (int i = 0; i < beam_num; i++)
+    {
+      if (is_finished (index, start, beam + i))
+      {
+        insert_completion (next_beam, &next_beam_num, beam_width, beam + i);
+        continue;
+      }
+      const IndexedNode *tail = beam[i].length
+                                ? beam[i].path[beam[i].length - 1] : start;
+      // successors are sorted, so only the first beam_width can make it
+      int successors_num = (tail->successors_num < beam_width)
+                           ? tail->successors_num : beam_width;
+      for (int j = 0; j < successors_num; j++)
+      {
+        Completion completion = beam[i];
+        completion.path[completion.length++] = tail->successors[j].node;
+        completion.probability *= tail->successors[j].probability;
+        insert_completion (next_beam, &next_beam_num, beam_width,
+                           &completion);
+      }
+      extended = true;
+    }
+    if (!extended)
+    {
+      break;
+    }
+    Completion *swap = beam;
+    beam = next_beam;
+    next_beam = swap;
+    beam_num = next_beam_num;
+  }
+  if (!beam[0].length)
+  {
+    return 0;
+  }
+  memcpy (completions, beam, beam_num * sizeof (Completion));
+  return beam_num;
+}
+
+void free_markov_index (MarkovIndex **index)
+{
+  free ((*index)->nodes);
+  free ((*index)->successors);
+  free ((*index)->table);
+  free (*index);
+  *index = NULL;
+}
@@ -0,0 +1,109 @@
+#ifndef _MARKOV_INDEX_H
+#define _MARKOV_INDEX_H
+
+#include "markov_chain.h"
+
+#define MAX_COMPLETION_STEPS 16
+#define MAX_BEAM_WIDTH 8
+
+typedef unsigned long (*hash_function)(void*);
+
+/***************************/
+/*        STRUCTS          */
+/***************************/
+
+typedef struct IndexedNode IndexedNode;
+
+typedef struct IndexSlot {
+    unsigned long hash;
+    IndexedNode *node; // NULL if the slot is empty
+} IndexSlot;
+
+typedef struct IndexedSuccessor {
+    const IndexedNode *node;
+    double probability;
+} IndexedSuccessor;
+
+struct IndexedNode {
+    MarkovNode *markov_node;
+    void *data; // markov_node->data, kept here to save a lookup
+    // the followers of markov_node, most probable first
+    IndexedSuccessor *successors;
+    int successors_num;
+};
+
+/**
+ * Read-only snapshot of a chain for next state queries. New words and counts
+ * added to the chain after build_markov_index are not seen by the index. The
+ * index points to the chain's nodes and their data, so the chain must not be
+ * decayed (decay_database) or freed while the index is alive.
+ */
+typedef struct MarkovIndex {
+    MarkovChain *markov_chain;
+    hash_function hash_func;
+    IndexedNode *nodes;
+    int nodes_num;
+    IndexedSuccessor *successors; // one block shared by all nodes
+    IndexSlot *table; // open addressing hash table of the nodes by data
+    unsigned long table_mask;
+} MarkovIndex;
+
+typedef struct Completion {
+    const IndexedNode *path[MAX_COMPLETION_STEPS];
+    int length;
+    double probability;
+} Completion;
+
+/**
+ * Build an index over the current content of markov_chain.
+ * @param markov_chain the chain to index, must outlive the index and not be
+ * decayed while it is alive
+ * @param hash_func hash of a state, equal states must have equal hashes
+ * @return the new index, NULL in case of allocation error
+ */
+MarkovIndex *build_markov_index (MarkovChain *markov_chain,
+                                 hash_function hash_func);
+
+/**
+ * Find the indexed node of a state.
+ * @param index
+ * @param data_ptr the state to look for
+ * @return the node wrapping the state, NULL if the state is not in the index
+ */
+const IndexedNode *index_lookup (const MarkovIndex *index, void *data_ptr);
+
+/**
+ * Get the k most probable next states of a state, without copying.
+ * @param index
+ * @param data_ptr the state to continue
+ * @param k maximal number of next states
+ * @param successors set to the most probable next state, the others follow
+ * it in decreasing probability
+ * @return number of next states in successors, at most k. 0 if the state is
+ * not in the index or has no next state.
+ */
+int top_k_next (const MarkovIndex *index, void *data_ptr, int k,
+                const IndexedSuccessor **successors);
+
+/**
+ * Find the most probable continuations of up to steps states with a beam
+ * search of the given width. A continuation stops early at a last state or at
+ * a state with no next state.
+ * @param index
+ * @param data_ptr the state to continue
+ * @param steps maximal length of a continuation, at most MAX_COMPLETION_STEPS
+ * @param beam_width number of continuations kept, at most MAX_BEAM_WIDTH
+ * @param completions array of beam_width completions to fill, most probable
+ * first
+ * @return number of completions filled
+ */
+int top_completions (const MarkovIndex *index, void *data_ptr, int steps,
+                     int beam_width, Completion *completions);
+
+/**
+ * Free the index. The indexed chain is not freed.
+ * @param index pointer to the index to free, set to NULL
+ */
+void free_markov_index (MarkovIndex **index);
+
+#endif /* _MARKOV_INDEX_H */
@@ -0,0 +1,59 @@
+#include "model_registry.h"
+#include <string.h>
+
+ModelRegistry *new_registry (void)
+{
+  return calloc (1, sizeof (ModelRegistry));
+}
+
+bool register_model (ModelRegistry *registry, const char *name,
+                     MarkovChain *markov_chain)
+{
+  if (get_model (registry, name))
+  {
+    return false;
+  }
+  char *name_copy = calloc (1, strlen (name) + 1);
+  Model *models = realloc (registry->models,
+                           (registry->models_num + 1) * sizeof (Model));
+  if (!name_copy || !models)
+  {
+    printf (ALLOCATION_ERROR_MASSAGE);
+    free (name_copy);
+    if (models)
+    {
+      registry->models = models;
+    }
+    return false;
+  }
+  strcpy (name_copy, name);
+  registry->models = models;
+  registry->models[registry->models_num].name = name_copy;
+  registry->models[registry->models_num].markov_chain = markov_chain;
+  registry->models_num++;
+  return true;
+}
+
+MarkovChain *get_model (const ModelRegistry *registry, const char *name)
+{
+  for (int index = 0; index < registry->models_num; index++)
+  {
+    if (!strcmp (registry->models[index].name, name))
+    {
+      return registry->models[index].markov_chain;
+    }
+  }
+  return NULL;
+}
+
+void free_registry (ModelRegistry **registry)
+{
+  for (int index = 0; index < (*registry)->models_num; index++)
+  {
+    free ((*registry)->models[index].name);
+    free_database (&(*registry)->models[index].markov_chain);
+  }
+  free ((*registry)->models);
+  free (*registry);
+  *registry = NULL;
+}
@@ -0,0 +1,51 @@
+#ifndef _MODEL_REGISTRY_H
+#define _MODEL_REGISTRY_H
+
+#include "markov_chain.h"
+
+typedef struct Model {
+    char *name;
+    MarkovChain *markov_chain;
+} Model;
+
+/**
+ * Named chains hosted in one process. Chains whose copy_func and free_data are
+ * intern_word and release_word share a single copy of every word.
+ */
+typedef struct ModelRegistry {
+    Model *models;
+    int models_num;
+} ModelRegistry;
+
+/**
+ * create new empty registry and return a pointer to it.
+ * @return pointer to the new registry, NULL in case of allocation error
+ */
+ModelRegistry *new_registry (void);
+
+/**
+ * Add a chain to the registry under the given name. On success the registry
+ * owns the chain and frees it in free_registry.
+ * @param registry
+ * @param name name to select the chain by, copied
+ * @param markov_chain the chain to add
+ * @return true on success, false if the name is taken or in case of
+ * allocation error
+ */
+bool register_model (ModelRegistry *registry, const char *name,
+                     MarkovChain *markov_chain);
+
+/**
+ * @param registry
+ * @param name the name the chain was registered under
+ * @return the chain registered under name, NULL if there is none
+ */
+MarkovChain *get_model (const ModelRegistry *registry, const char *name);
+
+/**
+ * Free the registry and all of its chains.
+ * @param registry pointer to the registry to free, set to NULL
+ */
+void free_registry (ModelRegistry **registry);
+
+#endif /* _MODEL_REGISTRY_H */
@@ -0,0 +1,267 @@
+#include <string.h>
+#include <unistd.h> // For fork(), pipe(), sysconf()
+#include <sys/wait.h> // For waitpid()
+#include "markov_chain.h"
+#include "corpus_pipeline.h"
+#include "model_registry.h"
+#include "vocabulary.h"
+
+#define MIN_ARGS_NUM 4
+#define SEED_INDEX 1
+#define MODELS_NUM_INDEX 2
+#define WORDS_TO_READ_INDEX 3
+#define FIRST_FILE_INDEX 4
+#define BASE 10
+
+#define MAX_TWEET 20
+#define MAX_NAME 32
+
+#define ARGS_NUM_ERROR_MESSAGE "Usage: models_bench <SEED> <NUM_OF_MODELS> \
+<WORDS_TO_READ> <FILE_PATH>...\n"
+#define FILE_PATH_ERROR "Error: the given file is not valid.\n"
+
+static bool end_of_sentence (void *data)
+{
+  char *string_data = (char *) data;
+  return !strcmp (&string_data[strlen (string_data) - 1], ".");
+}
+
+static void print_data (void *data)
+{
+  char *string_data = (char *) data;
+  if (end_of_sentence (data))
+  {
+    printf ("%s", string_data);
+  }
+  else
+  {
+    printf ("%s ", string_data);
+  }
+}
+
+static int comp_data (void *first, void *second)
+{
+  return strcmp ((char *) first, (char *) second);
+}
+
+static void *cpy_func (void *data)
+{
+  char *string_data = (char *) data;
+  char *new_data = calloc (1, strlen (string_data) + 1);
+  if (new_data)
+  {
+    strcpy (new_data, string_data);
+  }
+  return (void *) new_data;
+}
+
+static void free_data_func (void *data)
+{
+  free (data);
+}
+
+/**
+ * @return resident set size of this process in bytes, 0 if unknown
+ */
+static long get_rss (void)
+{
+  long pages = 0, resident = 0;
+  FILE *statm = fopen ("/proc/self/statm", "r");
+  if (!statm)
+  {
+    return 0;
+  }
+  if (fscanf (statm, "%ld %ld", &pages, &resident) != 2)
+  {
+    resident = 0;
+  }
+  fclose (statm);
+  return resident * sysconf (_SC_PAGESIZE);
+}
+
+/**
+ * Load one model from a file.
+ * @param shared true to keep the words in the shared vocabulary, false to give
+ * the model its own copy of each word
+ * @return the new chain, NULL on failure
+ */
+static MarkovChain *load_model (const char *path, int words_to_read,
+                                bool shared)
+{
+  FILE *file_ptr = fopen (path, "r");
+  if (!file_ptr)
+  {
+    printf (FILE_PATH_ERROR);
+    return NULL;
+  }
+  MarkovChain *markov_chain = calloc (1, sizeof (MarkovChain));
+  if (!markov_chain)
+  {
+    fclose (file_ptr);
+    return NULL;
+  }
+  markov_chain->copy_func = shared ? intern_word : cpy_func;
+  markov_chain->free_data = shared ? release_word : free_data_func;
+  markov_chain->comp_func = comp_data;
+  markov_chain->is_last = end_of_sentence;
+  markov_chain->print_func = print_data;
+  int fill = fill_database_pipelined (file_ptr, words_to_read, markov_chain);
+  fclose (file_ptr);
+  if (fill || !markov_chain->database)
+  {
+    free_database (&markov_chain);
+    return NULL;
+  }
+  return markov_chain;
+}
+
+/**
+ * Load models first_model ... first_model + models_num - 1 in a new process,
+ * each with its own copy of its words, as tweets_generator does.
+ * @return the resident set size of that process, -1 on failure
+ */
+static long private_models_rss (int first_model, int models_num,
+                                int words_to_read, char **paths, int paths_num)
+{
+  int fds[2];
+  if (pipe (fds))
+  {
+    return -1;
+  }
+  pid_t pid = fork ();
+  if (pid < 0)
+  {
+    close (fds[0]);
+    close (fds[1]);
+    return -1;
+  }
+  if (!pid)
+  {
+    close (fds[0]);
+    long rss = 0;
+    for (int model = first_model; model < first_model + models_num; model++)
+    {
+      // the process exits right after, the chains are not freed
+      if (!load_model (paths[model % paths_num], words_to_read, false))
+      {
+        rss = -1;
+        break;
+      }
+    }
+    rss = rss ? rss : get_rss ();
+    if (write (fds[1], &rss, sizeof (rss)) != sizeof (rss))
+    {
+      _exit (EXIT_FAILURE);
+    }
+    _exit (EXIT_SUCCESS);
+  }
+  close (fds[1]);
+  long rss = -1;
+  if (read (fds[0], &rss, sizeof (rss)) != sizeof (rss))
+  {
+    rss = -1;
+  }
+  close (fds[0]);
+  waitpid (pid, NULL, 0);
+  return rss;
+}
+
+/**
+ * Load every model in its own process, as separate tweets_generator
+ * processes would.
+ * @return the sum of the processes' resident set sizes, -1 on failure
+ */
+static long separate_processes_rss (int models_num, int words_to_read,
+                                    char **paths, int paths_num)
+{
+  long total = 0;
+  for (int model = 0; model < models_num; model++)
+  {
+    long rss = private_models_rss (model, 1, words_to_read, paths, paths_num);
+    if (rss < 0)
+    {
+      return -1;
+    }
+    total += rss;
+  }
+  return total;
+}
+
+static void print_tweet (ModelRegistry *registry, const char *name)
+{
+  MarkovChain *markov_chain = get_model (registry, name);
+  if (!markov_chain)
+  {
+    return;
+  }
+  MarkovWalk walk;
+  printf ("Tweet from %s: ", name);
+  walk_init (&walk, markov_chain, NULL, MAX_TWEET);
+  while (!walk_done (&walk))
+  {
+    markov_chain->print_func (walk_next (&walk)->data);
+  }
+  printf ("\n");
+}
+
+/**
+ * @param argc num of arguments
+ * @param argv 1) Seed
+ *             2) Number of models to load
+ *             3) Words to read from each file, -1 for all
+ *             4...) Files to load the models from, used in turns
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int main (int argc, char *argv[])
+{
+  if (argc - 1 < MIN_ARGS_NUM)
+  {
+    printf (ARGS_NUM_ERROR_MESSAGE);
+    return EXIT_FAILURE;
+  }
+  srand ((unsigned int) strtol (argv[SEED_INDEX], NULL, BASE));
+  int models_num = (int) strtol (argv[MODELS_NUM_INDEX], NULL, BASE);
+  int words_to_read = (int) strtol (argv[WORDS_TO_READ_INDEX], NULL, BASE);
+  char **paths = argv + FIRST_FILE_INDEX;
+  int paths_num = argc - FIRST_FILE_INDEX;
+
+  long separate_rss = separate_processes_rss (models_num, words_to_read,
+                                              paths, paths_num);
+  long private_rss = private_models_rss (0, models_num, words_to_read, paths,
+                                         paths_num);
+  ModelRegistry *registry = new_registry ();
+  if (!registry)
+  {
+    printf (ALLOCATION_ERROR_MASSAGE);
+    return EXIT_FAILURE;
+  }
+  char name[MAX_NAME];
+  for (int model = 0; model < models_num; model++)
+  {
+    snprintf (name, MAX_NAME, "model_%d", model);
+    MarkovChain *markov_chain = load_model (paths[model % paths_num],
+                                            words_to_read, true);
+    if (!markov_chain || !register_model (registry, name, markov_chain))
+    {
+      if (markov_chain)
+      {
+        free_database (&markov_chain);
+      }
+      free_registry (&registry);
+      return EXIT_FAILURE;
+    }
+  }
+  long shared_rss = get_rss ();
+
+  printf ("%d models, %d distinct words in the shared vocabulary\n",
+          models_num, vocabulary_size ());
+  printf ("Separate processes: %ld KB total RSS\n", separate_rss / 1024);
+  printf ("One process, words copied per model: %ld KB RSS\n",
+          private_rss / 1024);
+  printf ("One process, shared vocabulary: %ld KB RSS\n", shared_rss / 1024);
+  print_tweet (registry, "model_0");
+  snprintf (name, MAX_NAME, "model_%d", models_num - 1);
+  print_tweet (registry, name);
+  free_registry (&registry);
+  return EXIT_SUCCESS;
+}
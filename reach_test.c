@@ -0,0 +1,228 @@
+#include <string.h>
+#include "markov_chain.h"
+
+#define RANDOM_STATES 300
+#define LAST_EVERY 12 // one random state in LAST_EVERY is a last state
+#define MAX_FOLLOWERS 3
+#define LONG_PATH 100 // longer than MAX_REACH_LENGTH
+#define WALKS_NUM 2000
+#define MAX_WORD 32
+
+static int printed_num = 0;
+
+static bool end_of_sentence (void *data)
+{
+  char *string_data = (char *) data;
+  return !strcmp (&string_data[strlen (string_data) - 1], ".");
+}
+
+static int comp_data (void *first, void *second)
+{
+  return strcmp ((char *) first, (char *) second);
+}
+
+static void *cpy_func (void *data)
+{
+  char *string_data = (char *) data;
+  char *new_data = calloc (1, strlen (string_data) + 1);
+  if (new_data)
+  {
+    strcpy (new_data, string_data);
+  }
+  return (void *) new_data;
+}
+
+static void free_data_func (void *data)
+{
+  free (data);
+}
+
+/**
+ * Count the printed states instead of printing them.
+ */
+static void count_data (void *data)
+{
+  (void) data;
+  printed_num++;
+}
+
+static MarkovNode *add_word (MarkovChain *markov_chain, const char *format,
+                             int number)
+{
+  char word[MAX_WORD];
+  snprintf (word, MAX_WORD, format, number);
+  Node *node = add_to_database (markov_chain, word);
+  return node ? node->data : NULL;
+}
+
+/**
+ * Fill the chain with RANDOM_STATES states with up to MAX_FOLLOWERS random
+ * followers each (some with none, so some are dead ends), and a path of
+ * LONG_PATH states leading to a last state.
+ * @return true on success, false in case of allocation error
+ */
+static bool fill_database (MarkovChain *markov_chain)
+{
+  MarkovNode *nodes[RANDOM_STATES];
+  for (int i = 0; i < RANDOM_STATES; i++)
+  {
+    nodes[i] = add_word (markov_chain,
+                         (i % LAST_EVERY) ? "r%d" : "r%d.", i);
+    if (!nodes[i])
+    {
+      return false;
+    }
+  }
+  for (int i = 0; i < RANDOM_STATES; i++)
+  {
+    int followers_num = rand () % (MAX_FOLLOWERS + 1);
+    for (int j = 0; j < followers_num && i % LAST_EVERY; j++)
+    {
+      if (!add_node_to_frequencies_list (nodes[i],
+                                         nodes[rand () % RANDOM_STATES],
+                                         markov_chain))
+      {
+        return false;
+      }
+    }
+  }
+  MarkovNode *previous = add_word (markov_chain, "end%d.", 0);
+  for (int i = 0; i < LONG_PATH && previous; i++)
+  {
+    MarkovNode *curr = add_word (markov_chain, "p%d", i);
+    if (!curr || !add_node_to_frequencies_list (curr, previous, markov_chain))
+    {
+      return false;
+    }
+    previous = curr;
+  }
+  return previous != NULL;
+}
+
+/**
+ * Brute force distance: breadth first search forward from the node.
+ * @return fewest states of a walk from the node to a last state, -1 if none
+ */
+static int brute_distance (MarkovChain *markov_chain, MarkovNode *start,
+                           int nodes_num)
+{
+  MarkovNode **queue = malloc (nodes_num * sizeof (MarkovNode *));
+  int *distance = malloc (nodes_num * sizeof (int));
+  int queue_end = 0, result = -1;
+  queue[queue_end] = start;
+  distance[queue_end++] = 1;
+  for (int i = 0; i < queue_end && result < 0; i++)
+  {
+    if (markov_chain->is_last (queue[i]->data))
+    {
+      result = distance[i];
+      break;
+    }
+    for (int index = 0; index < queue[i]->follow_num; index++)
+    {
+      MarkovNode *next = queue[i]->frequencies_list[index].markov_node;
+      bool seen = false;
+      for (int j = 0; j < queue_end && !seen; j++)
+      {
+        seen = queue[j] == next;
+      }
+      if (!seen)
+      {
+        queue[queue_end] = next;
+        distance[queue_end++] = distance[i] + 1;
+      }
+    }
+  }
+  free (queue);
+  free (distance);
+  return result;
+}
+
+/**
+ * @return true if every last_distance matches the brute force distance
+ */
+static bool check_distances (MarkovChain *markov_chain)
+{
+  int nodes_num = 0, dead_ends = 0, longest = 0;
+  Node *node;
+  for (node = markov_chain->database->first; node; node = node->next)
+  {
+    nodes_num++;
+  }
+  for (node = markov_chain->database->first; node; node = node->next)
+  {
+    int expected = brute_distance (markov_chain, node->data, nodes_num);
+    if (node->data->last_distance != expected)
+    {
+      printf ("%s: last_distance %d, expected %d\n",
+              (char *) node->data->data, node->data->last_distance, expected);
+      return false;
+    }
+    dead_ends += expected < 0;
+    longest = (expected > longest) ? expected : longest;
+  }
+  printf ("%d states, %d dead ends, farthest last state %d away\n",
+          nodes_num, dead_ends, longest);
+  return dead_ends > 0 && longest > MAX_REACH_LENGTH;
+}
+
+/**
+ * @return true if every generated walk has a length in [min_length,
+ * max_length]
+ */
+static bool check_lengths (MarkovChain *markov_chain, int min_length,
+                           int max_length)
+{
+  for (int walk = 0; walk < WALKS_NUM; walk++)
+  {
+    printed_num = 0;
+    if (!generate_bounded_tweet (markov_chain, NULL, min_length, max_length))
+    {
+      printf ("[%d, %d]: no walk generated\n", min_length, max_length);
+      return false;
+    }
+    if (printed_num < min_length || printed_num > max_length)
+    {
+      printf ("[%d, %d]: walk of %d states\n", min_length, max_length,
+              printed_num);
+      return false;
+    }
+  }
+  return true;
+}
+
+int main (void)
+{
+  MarkovChain *markov_chain = calloc (1, sizeof (MarkovChain));
+  if (!markov_chain)
+  {
+    return EXIT_FAILURE;
+  }
+  markov_chain->copy_func = cpy_func;
+  markov_chain->free_data = free_data_func;
+  markov_chain->comp_func = comp_data;
+  markov_chain->is_last = end_of_sentence;
+  markov_chain->print_func = count_data;
+  srand (1);
+  int result = EXIT_FAILURE;
+  if (fill_database (markov_chain) && compute_reachability (markov_chain)
+      && check_distances (markov_chain)
+      && check_lengths (markov_chain, 1, 1)
+      && check_lengths (markov_chain, 2, 3)
+      && check_lengths (markov_chain, 5, 8)
+      && check_lengths (markov_chain, 10, 12)
+      && check_lengths (markov_chain, 30, MAX_REACH_LENGTH))
+  {
+    // the start of the long path is too far from its last state
+    MarkovNode *far = get_node_from_database (markov_chain, "p99")->data;
+    printed_num = 0;
+    if (!generate_bounded_tweet (markov_chain, far, 1, MAX_REACH_LENGTH)
+        && !printed_num)
+    {
+      result = EXIT_SUCCESS;
+    }
+  }
+  printf ("%s\n", result == EXIT_SUCCESS ? "PASS" : "FAIL");
+  free_database (&markov_chain);
+  return result;
+}
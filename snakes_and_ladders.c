@@ -1,4 +1,9 @@
 #include <string.h> // For strlen(), strcmp(), strcpy()
+#include <stdint.h> // For uint32_t
+#include <time.h> // For clock()
+#ifdef __AVX2__
+#include <immintrin.h> // For the AVX2 gathers of step_walkers
+#endif
 #include "markov_chain.h"
 
 #define MAX(X, Y) (((X) < (Y)) ? (Y) : (X))
@@ -17,6 +22,8 @@
 #define DICE_MAX 6
 #define NUM_OF_TRANSITIONS 20
 
+#define WALKER_LANES 16
+
 /**
  * represents the transitions by ladders and snakes in the game
  * each tuple (x,y) represents a ladder from x to if x<y or a snake otherwise
@@ -53,6 +60,28 @@ typedef struct Cell
     //both ladder_to and snake_to should be -1 if the Cell doesn't have them
 } Cell;
 
+/**
+ * Flattened transition table of the board for the lockstep walkers: the
+ * possible moves from cell c are next[c * DICE_MAX] ...
+ * next[c * DICE_MAX + options[c] - 1], all equally likely.
+ */
+typedef struct LockstepBoard
+{
+    uint32_t options[BOARD_SIZE + 1];
+    uint32_t next[(BOARD_SIZE + 1) * DICE_MAX];
+} LockstepBoard;
+
+/**
+ * Structure of arrays holding WALKER_LANES walkers that are advanced together.
+ */
+typedef struct WalkerLanes
+{
+    uint32_t cell[WALKER_LANES];
+    uint32_t length[WALKER_LANES]; // number of cells visited so far
+    uint32_t rng[WALKER_LANES]; // xorshift32 state of each walker
+    uint32_t pending[WALKER_LANES]; // walks left to start in this lane
+} WalkerLanes;
+
 /** Error handler **/
 static int handle_error (char *error_msg, MarkovChain **database)
 {
@@ -207,6 +236,212 @@ static void print_cell (void *data)
   printf ("[%d] -> ", cell_data->number);
 }
 
+#ifdef SNAKES_BENCHMARK
+/**
+ * fills the lockstep table from the transitions array and DICE_MAX, with the
+ * same moves fill_database gives the markov chain.
+ * @param board table to fill
+ */
+static void create_lockstep_board (LockstepBoard *board)
+{
+  uint32_t jump_to[BOARD_SIZE + 1] = {0};
+  for (int i = 0; i < NUM_OF_TRANSITIONS; i++)
+  {
+    jump_to[transitions[i][0]] = transitions[i][1];
+  }
+  for (uint32_t cell = 0; cell <= BOARD_SIZE; cell++)
+  {
+    uint32_t *moves = board->next + cell * DICE_MAX;
+    board->options[cell] = 0;
+    if (jump_to[cell])
+    {
+      moves[board->options[cell]++] = jump_to[cell];
+      continue;
+    }
+    for (uint32_t j = 1; j <= DICE_MAX; j++)
+    {
+      moves[j - 1] = cell;
+      if (cell >= 1 && cell + j <= BOARD_SIZE)
+      {
+        moves[board->options[cell]++] = cell + j;
+      }
+    }
+  }
+}
+
+#ifdef __AVX2__
+/**
+ * Advance every active walker by one move, 8 lanes per instruction. The table
+ * lookups are AVX2 gathers. Walkers that reached the last cell or max_length
+ * are masked out, and their lane starts its next pending walk from cell 1.
+ * @return number of walkers that moved
+ */
+static uint32_t step_walkers (const LockstepBoard *board, WalkerLanes *lanes,
+                              uint32_t max_length)
+{
+  const __m256i last = _mm256_set1_epi32 (BOARD_SIZE);
+  const __m256i max = _mm256_set1_epi32 ((int) max_length);
+  const __m256i first = _mm256_set1_epi32 (1);
+  const __m256i dice = _mm256_set1_epi32 (DICE_MAX);
+  const __m256i zero = _mm256_setzero_si256 ();
+  uint32_t moved = 0;
+  for (int lane = 0; lane < WALKER_LANES; lane += 8)
+  {
+    __m256i cell = _mm256_loadu_si256 ((__m256i *) (lanes->cell + lane));
+    __m256i length = _mm256_loadu_si256 ((__m256i *) (lanes->length + lane));
+    __m256i x = _mm256_loadu_si256 ((__m256i *) (lanes->rng + lane));
+    __m256i pending = _mm256_loadu_si256 ((__m256i *) (lanes->pending + lane));
+    __m256i active = _mm256_andnot_si256 (_mm256_cmpeq_epi32 (cell, last),
+                                          _mm256_cmpgt_epi32 (max, length));
+    x = _mm256_xor_si256 (x, _mm256_slli_epi32 (x, 13));
+    x = _mm256_xor_si256 (x, _mm256_srli_epi32 (x, 17));
+    x = _mm256_xor_si256 (x, _mm256_slli_epi32 (x, 5));
+    __m256i options = _mm256_i32gather_epi32 ((const int *) board->options,
+                                              cell, 4);
+    __m256i pick = _mm256_srli_epi32 (
+        _mm256_mullo_epi32 (_mm256_srli_epi32 (x, 16), options), 16);
+    __m256i to = _mm256_i32gather_epi32 (
+        (const int *) board->next,
+        _mm256_add_epi32 (_mm256_mullo_epi32 (cell, dice), pick), 4);
+    cell = _mm256_blendv_epi8 (cell, to, active);
+    length = _mm256_sub_epi32 (length, active); // active lanes are -1
+    moved += __builtin_popcount (_mm256_movemask_ps (
+        _mm256_castsi256_ps (active)));
+    __m256i finished = _mm256_or_si256 (
+        _mm256_cmpeq_epi32 (cell, last),
+        _mm256_cmpeq_epi32 (length, max));
+    __m256i refill = _mm256_and_si256 (
+        finished, _mm256_cmpgt_epi32 (pending, zero));
+    cell = _mm256_blendv_epi8 (cell, first, refill);
+    length = _mm256_blendv_epi8 (length, first, refill);
+    pending = _mm256_add_epi32 (pending, refill);
+    _mm256_storeu_si256 ((__m256i *) (lanes->cell + lane), cell);
+    _mm256_storeu_si256 ((__m256i *) (lanes->length + lane), length);
+    _mm256_storeu_si256 ((__m256i *) (lanes->rng + lane), x);
+    _mm256_storeu_si256 ((__m256i *) (lanes->pending + lane), pending);
+  }
+  return moved;
+}
+#else
+/**
+ * Advance every active walker by one move, the same way as the AVX2 version
+ * above. Walkers that reached the last cell or max_length are masked out, and
+ * their lane starts its next pending walk from cell 1.
+ * @return number of walkers that moved
+ */
+static uint32_t step_walkers (const LockstepBoard *board, WalkerLanes *lanes,
+                              uint32_t max_length)
+{
+  uint32_t moved = 0;
+  for (int lane = 0; lane < WALKER_LANES; lane++)
+  {
+    uint32_t cell = lanes->cell[lane];
+    uint32_t length = lanes->length[lane];
+    uint32_t active = (cell != BOARD_SIZE) & (length < max_length);
+    uint32_t x = lanes->rng[lane];
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    lanes->rng[lane] = x;
+    uint32_t pick = ((x >> 16) * board->options[cell]) >> 16;
+    uint32_t to = board->next[cell * DICE_MAX + pick];
+    cell = active ? to : cell;
+    length += active;
+    moved += active;
+    uint32_t refill = ((cell == BOARD_SIZE) | (length == max_length))
+                      & (lanes->pending[lane] > 0);
+    lanes->cell[lane] = refill ? 1 : cell;
+    lanes->length[lane] = refill ? 1 : length;
+    lanes->pending[lane] -= refill;
+  }
+  return moved;
+}
+#endif
+
+/**
+ * Run walks_num walks from cell 1, spread evenly over WALKER_LANES lanes. A
+ * lane starts its next walk as soon as its current one ends, so lanes do not
+ * wait for the slowest walker of a batch.
+ * @return total number of moves made by all walkers
+ */
+static long run_lockstep_walks (const LockstepBoard *board, int walks_num,
+                                uint32_t seed)
+{
+  WalkerLanes lanes;
+  long steps = 0;
+  for (int lane = 0; lane < WALKER_LANES; lane++)
+  {
+    uint32_t lane_walks = walks_num / WALKER_LANES
+                          + (lane < walks_num % WALKER_LANES);
+    // lanes with no walk start retired
+    lanes.cell[lane] = lane_walks ? 1 : BOARD_SIZE;
+    lanes.length[lane] = 1;
+    lanes.rng[lane] = ((seed + lane) * 2654435761u) | 1;
+    lanes.pending[lane] = lane_walks ? lane_walks - 1 : 0;
+  }
+  uint32_t moved;
+  do
+  {
+    moved = step_walkers (board, &lanes, MAX_GENERATION_LENGTH);
+    steps += moved;
+  }
+  while (moved);
+  return steps;
+}
+
+/**
+ * Run walks_num walks from first_cell through the markov chain, the same
+ * moves generate_tweet makes, without printing.
+ * @return total number of moves made by all walkers
+ */
+static long run_scalar_walks (MarkovChain *markov_chain,
+                              MarkovNode *first_cell, int walks_num)
+{
+  long steps = 0;
+  for (int walk = 0; walk < walks_num; walk++)
+  {
+    MarkovNode *node = first_cell;
+    for (int length = 1; length < MAX_GENERATION_LENGTH
+                         && !markov_chain->is_last (node->data); length++)
+    {
+      node = get_next_random_node (node);
+      if (!node)
+      {
+        break;
+      }
+      steps++;
+    }
+  }
+  return steps;
+}
+
+/**
+ * Time the scalar and the lockstep walkers on walks_num walks each and print
+ * their walker-steps per second.
+ */
+static void benchmark_walks (MarkovChain *markov_chain, int walks_num,
+                             uint32_t seed)
+{
+  LockstepBoard board;
+  create_lockstep_board (&board);
+  MarkovNode *first_cell = markov_chain->database->first->data;
+
+  clock_t start = clock ();
+  long scalar_steps = run_scalar_walks (markov_chain, first_cell, walks_num);
+  double scalar_time = (double) (clock () - start) / CLOCKS_PER_SEC;
+
+  start = clock ();
+  long lockstep_steps = run_lockstep_walks (&board, walks_num, seed);
+  double lockstep_time = (double) (clock () - start) / CLOCKS_PER_SEC;
+
+  printf ("Scalar: %ld walker-steps in %.3fs, %.0f walker-steps/sec\n",
+          scalar_steps, scalar_time, scalar_steps / MAX(scalar_time, 1e-9));
+  printf ("Lockstep (%d lanes): %ld walker-steps in %.3fs, "
+          "%.0f walker-steps/sec\n", WALKER_LANES, lockstep_steps,
+          lockstep_time, lockstep_steps / MAX(lockstep_time, 1e-9));
+}
+#endif
+
 static int get_path (char **argv, MarkovChain *markov_chain)
 {
   int fill = 0;
@@ -217,11 +452,22 @@ static int get_path (char **argv, MarkovChain *markov_chain)
     return 1;
   }
   int tweets_num = strtol (argv[PATH_INDEX], NULL, BASE);
+#ifdef SNAKES_BENCHMARK
+  benchmark_walks (markov_chain, tweets_num,
+                   (uint32_t) strtol (argv[SEED_INDEX], NULL, BASE));
+  free_database(&markov_chain);
+  return 0;
+#endif
   MarkovNode *first_cell = markov_chain->database->first->data;
+  MarkovWalk walk;
   for (int tweet = 0; tweet < tweets_num; tweet++)
   {
     printf ("Random Walk %d: ", tweet + 1);
-    generate_tweet(markov_chain, first_cell, MAX_GENERATION_LENGTH);
+    walk_init (&walk, markov_chain, first_cell, MAX_GENERATION_LENGTH);
+    while (!walk_done (&walk))
+    {
+      print_cell (walk_next (&walk)->data);
+    }
     printf ("\n");
   }
   free_database(&markov_chain);
@@ -1,9 +1,8 @@
 #include <stdio.h>
 #include "markov_chain.h"
+#include "corpus_pipeline.h"
 #include <string.h>
 
-#define MAX_SENTENCE 1000
-
 #define ARGS_NUM_1 3
 #define ARGS_NUM_2 4
 
@@ -12,8 +11,6 @@
 #define FILE_PATH_INDEX 3
 #define WORDS_TO_READ_INDEX 4
 
-#define READ_ALL_FILE (-1)
-
 #define BASE 10
 
 #define MAX_TWEET 20
@@ -65,60 +62,20 @@ static void free_data_func (void *data)
   free (string_data);
 }
 
-static int fill_database (FILE *fp, int words_to_read,
-                          MarkovChain *markov_chain)
-{
-  char text[MAX_SENTENCE];
-  int words_counter = 1;
-  while (fgets (text, MAX_SENTENCE, fp) &&
-         (words_to_read == READ_ALL_FILE || words_counter <= words_to_read))
-  {
-    char *data = strtok (text, " \n\r");
-    Node *previous_node = NULL;
-    while ((data != NULL) &&
-           (words_to_read == READ_ALL_FILE || words_counter <= words_to_read))
-    {
-      Node *now_node = add_to_database (markov_chain, data);
-      if (now_node != NULL)
-      {
-        if ((previous_node != NULL)
-            && !end_of_sentence (previous_node->data->data))
-        {
-          bool add_to_database = add_node_to_frequencies_list (
-              previous_node->data,
-              now_node->data, markov_chain);
-          if (add_to_database == false)
-          {
-            return 1;
-          }
-        }
-        data = strtok (NULL, " \n\r");
-        previous_node = now_node;
-        words_counter++;
-      }
-      else
-      {
-        return 1;
-      }
-    }
-  }
-  return 0;
-}
-
 static int get_tweets (FILE *file_ptr, char **argv, MarkovChain *markov_chain,
                        bool with_words_to_read)
 {
   int fill = 0;
   if (with_words_to_read)
   {
-    fill = fill_database (file_ptr, (int)
+    fill = fill_database_pipelined (file_ptr, (int)
         strtol (argv[WORDS_TO_READ_INDEX],
                 NULL, BASE), markov_chain);
   }
   else
   {
-    fill = fill_database (file_ptr,
-                          READ_ALL_FILE, markov_chain);
+    fill = fill_database_pipelined (file_ptr,
+                                    READ_ALL_FILE, markov_chain);
   }
   if (fill)
   {
@@ -127,10 +84,15 @@ static int get_tweets (FILE *file_ptr, char **argv, MarkovChain *markov_chain,
     return 1;
   }
   int tweets_num = strtol (argv[TWEETS_NUM_INDEX], NULL, BASE);
+  MarkovWalk walk;
   for (int tweet = 0; tweet < tweets_num; tweet++)
   {
     printf ("Tweet %d: ", tweet + 1);
-    generate_tweet (markov_chain, NULL, MAX_TWEET);
+    walk_init (&walk, markov_chain, NULL, MAX_TWEET);
+    while (!walk_done (&walk))
+    {
+      print_data (walk_next (&walk)->data);
+    }
     printf ("\n");
   }
   fclose (file_ptr);
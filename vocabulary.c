@@ -0,0 +1,157 @@
+#include "vocabulary.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h> // For offsetof()
+#include <string.h>
+#include <pthread.h>
+
+#define FIRST_BUCKETS_NUM 1024
+
+typedef struct InternedWord {
+    struct InternedWord *next; // next word in the same bucket
+    unsigned long hash;
+    int references;
+    char word[];
+} InternedWord;
+
+typedef struct Vocabulary {
+    InternedWord **buckets;
+    unsigned long buckets_num; // power of 2
+    int words_num;
+} Vocabulary;
+
+static Vocabulary vocabulary = {NULL, 0, 0};
+static pthread_mutex_t vocabulary_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static InternedWord *get_interned (void *data)
+{
+  return (InternedWord *) ((char *) data - offsetof (InternedWord, word));
+}
+
+/**
+ * FNV-1a hash of a string.
+ */
+static unsigned long hash_word (const char *word)
+{
+  unsigned long hash = 14695981039346656037UL;
+  for (const unsigned char *c = (const unsigned char *) word; *c; c++)
+  {
+    hash = (hash ^ *c) * 1099511628211UL;
+  }
+  return hash;
+}
+
+/**
+ * Double the number of buckets, or create the first ones.
+ * @return true on success, false in case of allocation error
+ */
+static bool grow_buckets (void)
+{
+  unsigned long buckets_num = vocabulary.buckets_num
+                              ? 2 * vocabulary.buckets_num : FIRST_BUCKETS_NUM;
+  InternedWord **buckets = calloc (buckets_num, sizeof (InternedWord *));
+  if (!buckets)
+  {
+    return false;
+  }
+  for (unsigned long i = 0; i < vocabulary.buckets_num; i++)
+  {
+    InternedWord *interned = vocabulary.buckets[i], *next = NULL;
+    for (; interned; interned = next)
+    {
+      next = interned->next;
+      unsigned long bucket = interned->hash & (buckets_num - 1);
+      interned->next = buckets[bucket];
+      buckets[bucket] = interned;
+    }
+  }
+  free (vocabulary.buckets);
+  vocabulary.buckets = buckets;
+  vocabulary.buckets_num = buckets_num;
+  return true;
+}
+
+static void *intern_word_locked (void *data)
+{
+  char *string_data = (char *) data;
+  unsigned long hash = hash_word (string_data);
+  if (vocabulary.buckets)
+  {
+    InternedWord *interned = vocabulary.buckets[hash
+                                                & (vocabulary.buckets_num - 1)];
+    for (; interned; interned = interned->next)
+    {
+      if (interned->hash == hash && !strcmp (interned->word, string_data))
+      {
+        interned->references++;
+        return interned->word;
+      }
+    }
+  }
+  if ((unsigned long) vocabulary.words_num >= vocabulary.buckets_num
+      && !grow_buckets ())
+  {
+    return NULL;
+  }
+  size_t length = strlen (string_data);
+  InternedWord *interned = malloc (sizeof (InternedWord) + length + 1);
+  if (!interned)
+  {
+    return NULL;
+  }
+  memcpy (interned->word, string_data, length + 1);
+  interned->hash = hash;
+  interned->references = 1;
+  unsigned long bucket = hash & (vocabulary.buckets_num - 1);
+  interned->next = vocabulary.buckets[bucket];
+  vocabulary.buckets[bucket] = interned;
+  vocabulary.words_num++;
+  return interned->word;
+}
+
+static void release_word_locked (void *data)
+{
+  InternedWord *interned = get_interned (data);
+  if (--interned->references)
+  {
+    return;
+  }
+  InternedWord **link = vocabulary.buckets
+                        + (interned->hash & (vocabulary.buckets_num - 1));
+  while (*link != interned)
+  {
+    link = &(*link)->next;
+  }
+  *link = interned->next;
+  free (interned);
+  vocabulary.words_num--;
+  if (!vocabulary.words_num)
+  {
+    free (vocabulary.buckets);
+    vocabulary.buckets = NULL;
+    vocabulary.buckets_num = 0;
+  }
+}
+
+void *intern_word (void *data)
+{
+  pthread_mutex_lock (&vocabulary_lock);
+  void *interned = intern_word_locked (data);
+  pthread_mutex_unlock (&vocabulary_lock);
+  return interned;
+}
+
+void release_word (void *data)
+{
+  pthread_mutex_lock (&vocabulary_lock);
+  release_word_locked (data);
+  pthread_mutex_unlock (&vocabulary_lock);
+}
+
+int vocabulary_size (void)
+{
+  pthread_mutex_lock (&vocabulary_lock);
+  int words_num = vocabulary.words_num;
+  pthread_mutex_unlock (&vocabulary_lock);
+  return words_num;
+}
@@ -0,0 +1,33 @@
+#ifndef _VOCABULARY_H
+#define _VOCABULARY_H
+
+#include <stdbool.h>
+
+/**
+ * Process wide set of interned words, shared by every chain that uses
+ * intern_word and release_word as its copy_func and free_data. Each word is
+ * stored once, with a count of the chains' references to it. The functions
+ * below take a lock, so models can be loaded by several threads at once.
+ */
+
+/**
+ * Get the interned copy of a word, adding it to the vocabulary if it is new,
+ * and take a reference to it. Matches copy_function.
+ * @param data the word, a null terminated string
+ * @return the interned word, NULL in case of allocation error
+ */
+void *intern_word (void *data);
+
+/**
+ * Drop a reference taken by intern_word, freeing the word with the last one.
+ * Matches free_data.
+ * @param data an interned word
+ */
+void release_word (void *data);
+
+/**
+ * @return number of distinct words in the vocabulary
+ */
+int vocabulary_size (void);
+
+#endif /* _VOCABULARY_H */